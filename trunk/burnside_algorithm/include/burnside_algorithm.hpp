@@ -3,11 +3,53 @@
 
 #include<armadillo>
 #include<vector>
+#include<string>
+#include<random>
 
 std::vector<std::vector<unsigned>> determine_conj_classes(const arma::Mat<unsigned> & multiplication);
+// funkcja ta zwraca dla kazdego elementu grupy indeks jego klasy sprzezonosci:
+std::vector<unsigned> determine_class_of_elements(const std::vector<std::vector<unsigned>> & conj_classes);
 // funkcja ta buduje macierze (M_R)_{ST} o elementach c_{RST}:
 std::vector<arma::mat> bulid_Ms(const arma::Mat<unsigned> & multiplication, std::vector<std::vector<unsigned> > conj_classes);
+// funkcje te buduja macierz (M_R)_{ST} dla jednej klasy R:
+arma::Mat<arma::u64> count_class_products(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned>> & conj_classes,
+        const std::vector<unsigned> & class_of_elements, unsigned R);
+arma::mat normalize_class_products(const arma::Mat<arma::u64> & counts, const std::vector<std::vector<unsigned>> & conj_classes);
+std::vector<arma::cx_vec> build_character_table_from_Ms(const std::vector<arma::mat> & Ms, const std::vector<std::vector<unsigned>> &conj_classes);
 std::vector<arma::cx_vec> build_character_table(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned>> &conj_classes);
 std::vector<arma::cx_vec> build_character_table(const arma::Mat<unsigned> & multiplication);
 
-#endif
\ No newline at end of file
+// -------------------------- obliczenia podzielone na czesci (shards) -------------------------
+// Jedna czesc to macierz M_R dla jednej klasy R, zapisywana do osobnego pliku w katalogu shard_dir.
+// Katalog przygotowuje sie raz funkcja prepare_M_shards (zapisuje ona klasy sprzezonosci i skrot tabeli mnozenia),
+// czesci mozna liczyc w niezaleznych procesach, a nastepnie polaczyc funkcja merge_M_shards.
+std::string M_shards_conj_classes_file_name(const std::string & shard_dir);
+std::string M_shard_file_name(const std::string & shard_dir, unsigned R);
+// Zwraca false, gdy katalog byl juz przygotowany (wtedy nic nie jest zapisywane):
+bool prepare_M_shards(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned>> & conj_classes, const std::string & shard_dir);
+std::vector<std::vector<unsigned>> load_M_shards_conj_classes(const std::string & shard_dir);
+arma::u64 load_M_shards_multiplication_hash(const std::string & shard_dir);
+arma::u64 multiplication_hash(const arma::Mat<unsigned> & multiplication);
+bool is_M_shard_done(const std::vector<std::vector<unsigned>> & conj_classes, unsigned R, const std::string & shard_dir);
+// Zwraca false, gdy czesc byla juz policzona (wtedy nic nie jest liczone):
+bool build_M_shard(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned>> & conj_classes, unsigned R, const std::string & shard_dir);
+std::vector<arma::mat> merge_M_shards(const std::vector<std::vector<unsigned>> & conj_classes, const std::string & shard_dir);
+
+// -------------------------- tabela charakterow z losowanych iloczynow ------------------------
+// Dla bardzo duzych grup stale c_{RST} sa szacowane z losowo wybranych par (r, s),
+// a liczba losowan jest podwajana az tabela charakterow przejdzie weryfikacje.
+// Zliczenia iloczynow r*s zbierane przez kolejne wywolania estimate_Ms
+// (dla kazdej pary klas R <= S: liczby iloczynow wpadajacych do kolejnych klas T, liczba losowan
+// oraz czy para zostala przeliczona dokladnie):
+struct SampledProducts {
+    std::vector<std::vector<unsigned long long>> hits;
+    std::vector<unsigned long long> number_of_draws;
+    std::vector<bool> is_exact;
+};
+std::vector<arma::mat> estimate_Ms(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned>> & conj_classes,
+        SampledProducts & sampled_products, unsigned long long number_of_samples, std::mt19937 & generator, double & confidence, bool & is_exact);
+bool verify_character_table(const std::vector<arma::cx_vec> & character_table, const std::vector<std::vector<unsigned>> & conj_classes, double threshold = 1e-5);
+std::vector<arma::cx_vec> build_character_table_sampled(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned>> & conj_classes,
+        unsigned long long initial_number_of_samples = 1000, unsigned seed = 0);
+
+#endif
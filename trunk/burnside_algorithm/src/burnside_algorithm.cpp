@@ -56,23 +56,57 @@ std::vector<std::vector<unsigned> > determine_conj_classes(const arma::Mat<unsig
 
 std::vector<arma::mat> bulid_Ms(const arma::Mat<unsigned> & multiplication, std::vector<std::vector<unsigned> > conj_classes) {
     unsigned number_of_conj_classes = conj_classes.size();
-    std::vector<unsigned> sizes_of_conj_classes;
-    for (std::vector<unsigned> conj_class : conj_classes) sizes_of_conj_classes.push_back(conj_class.size());
-    std::vector<arma::mat> Ms(number_of_conj_classes, arma::mat(number_of_conj_classes, number_of_conj_classes, arma::fill::zeros));
-    for (unsigned R = 0; R < number_of_conj_classes; R++)
-        for (unsigned S = 0; S < number_of_conj_classes; S++)
-            for (unsigned r : conj_classes[R])
-                for (unsigned s : conj_classes[S])
-                    for (unsigned T = 0; T < number_of_conj_classes; T++)
-                        for (unsigned t : conj_classes[T])
-                            if (multiplication(r, s) == t) Ms[R](S, T) += 1;
+    std::vector<unsigned> class_of_elements = determine_class_of_elements(conj_classes);
+    std::vector<arma::mat> Ms;
     for (unsigned R = 0; R < number_of_conj_classes; R++)
-        for (unsigned S = 0; S < number_of_conj_classes; S++)
-            for (unsigned T = 0; T < number_of_conj_classes; T++)
-                Ms[R](S, T) /= sqrt(sizes_of_conj_classes[S]) * sqrt(sizes_of_conj_classes[T]);
+        Ms.push_back(normalize_class_products(count_class_products(multiplication, conj_classes, class_of_elements, R), conj_classes));
     return Ms;
 }
 
+/*
+ * The functions that determines, for every group element,
+ * the index of the conjugacy class the element belongs to.
+ */
+std::vector<unsigned> determine_class_of_elements(const std::vector<std::vector<unsigned> > & conj_classes) {
+    unsigned size_of_group = 0;
+    for (const std::vector<unsigned> & conj_class : conj_classes) size_of_group += conj_class.size();
+    std::vector<unsigned> class_of_elements(size_of_group);
+    for (unsigned T = 0; T < conj_classes.size(); T++)
+        for (unsigned t : conj_classes[T])
+            class_of_elements[t] = T;
+    return class_of_elements;
+}
+
+/*
+ * The functions that counts the products r*s (r from the class R, s from the class S)
+ * falling into the class T.
+ * The counts are returned as the (S, T) matrix elements.
+ * Note: the counts equal |T| * c_{RST}.
+ */
+arma::Mat<arma::u64> count_class_products(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned> > & conj_classes,
+        const std::vector<unsigned> & class_of_elements, unsigned R) {
+    unsigned number_of_conj_classes = conj_classes.size();
+    arma::Mat<arma::u64> counts(number_of_conj_classes, number_of_conj_classes, arma::fill::zeros);
+    for (unsigned r : conj_classes[R])
+        for (unsigned S = 0; S < number_of_conj_classes; S++)
+            for (unsigned s : conj_classes[S])
+                counts(S, class_of_elements[multiplication(r, s)]) += 1;
+    return counts;
+}
+
+/*
+ * The functions that turns the counts of the products (see count_class_products)
+ * into the (M_R)_{ST} matrix.
+ */
+arma::mat normalize_class_products(const arma::Mat<arma::u64> & counts, const std::vector<std::vector<unsigned> > & conj_classes) {
+    unsigned number_of_conj_classes = conj_classes.size();
+    arma::mat M(number_of_conj_classes, number_of_conj_classes);
+    for (unsigned S = 0; S < number_of_conj_classes; S++)
+        for (unsigned T = 0; T < number_of_conj_classes; T++)
+            M(S, T) = counts(S, T) / (sqrt(conj_classes[S].size()) * sqrt(conj_classes[T].size()));
+    return M;
+}
+
 /* 
  * The functions that determines the character table:
  * 
@@ -97,15 +131,28 @@ std::vector<arma::mat> bulid_Ms(const arma::Mat<unsigned> & multiplication, std:
  * (not one entry for one group element).
  */
 std::vector<arma::cx_vec> build_character_table(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned> > & conj_classes) {
+    // Budujemy macierze M wystepujace w algorytmie Burnsidea:
+    std::vector<arma::mat> Ms = bulid_Ms(multiplication, conj_classes);
+    return build_character_table_from_Ms(Ms, conj_classes);
+}
+
+/* 
+ * The functions that determines the character table
+ * out of the already built (M_R)_{ST} matrices (see bulid_Ms).
+ * 
+ * Returns:
+ * The same as build_character_table.
+ */
+std::vector<arma::cx_vec> build_character_table_from_Ms(const std::vector<arma::mat> & Ms, const std::vector<std::vector<unsigned> > & conj_classes) {
     // Tu bedzie zapisywany wynik tej tunkcji.
     std::vector<arma::cx_vec> character_table;
     // Pomocnicza wielkosci: rzad grupy, liosc klas sprzezonosci oraz ilosci elelentow w kolejnych klasach sprzezonosci
-    const double size_of_group = multiplication.n_rows;
     const unsigned number_of_conj_classes = conj_classes.size();
     std::vector<unsigned> sizes_of_conj_classes;
     for (std::vector<unsigned> conjClas : conj_classes) sizes_of_conj_classes.push_back(conjClas.size());
-    // Budujemy macierze M wystepujace w algorytmie Burnsidea i (wspolnie) je diagonalizujemy
-    std::vector<arma::mat> Ms = bulid_Ms(multiplication, conj_classes);
+    double size_of_group = 0;
+    for (unsigned size_of_conj_class : sizes_of_conj_classes) size_of_group += size_of_conj_class;
+    // Macierze M wystepujace w algorytmie Burnsidea (wspolnie) diagonalizujemy
     // Techniczne przerobienia max -> cx_max:
     std::vector<arma::cx_mat> cxMs;
     const arma::mat zero_mat(number_of_conj_classes, number_of_conj_classes, arma::fill::zeros);
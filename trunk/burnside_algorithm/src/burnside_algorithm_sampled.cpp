@@ -0,0 +1,289 @@
+#include<armadillo>
+#include<cmath>
+#include<vector>
+#include<string>
+#include<random>
+#include<algorithm>
+#include<limits>
+#include<iostream>
+#include<stdexcept>
+
+#include<burnside_algorithm.hpp>
+
+// *********************************************************************************************
+// ************************  Class algebra estimated from sampled products  ********************
+// *********************************************************************************************
+
+// For the groups too large to count every product r*s,
+// the c_{RST} constants are estimated by sampling random pairs (r from R, s from S).
+// The estimates are pooled and rounded using the symmetry of the numbers
+// Gamma(A, B, C) = #{(a, b, c) from A x B x C : a b c = e},
+// which are invariant under any permutation of the classes A, B, C
+// (since the class algebra is commutative) and relate to the constants via
+// Gamma(R, S, T*) = |T| c_{RST}  (T* being the class of the inverses of the elements of T).
+// So the products r*s from any of the pairs of classes (R, S), (R, T*), (S, T*)
+// give an estimate of the same Gamma(R, S, T*), which has to be a multiple of lcm(|R|, |S|, |T|).
+// The rounded numbers are then adjusted to satisfy the constraint: sum_T |T| c_{RST} = |R| |S|.
+// A pair of classes is enumerated exactly when |R| |S| does not exceed the number of samples.
+
+// The estimate of one Gamma(A, B, C):
+struct GammaEstimate {
+    double weighted_sum = 0; // sum of the estimates weighted with their inverse variances,
+    double weight = 0; // sum of the inverse variances,
+    bool is_exact = false; // true if the value comes from the exact enumeration,
+    bool is_locked = false; // true if the value may no longer be adjusted,
+    unsigned long long value = 0; // the rounded (or exact) value.
+};
+
+/*
+ * The function that returns the index of Gamma(A, B, C)
+ * (the same for any permutation of A, B, C).
+ */
+static unsigned long long gamma_index(unsigned A, unsigned B, unsigned C) {
+    if (A > B) std::swap(A, B);
+    if (B > C) std::swap(B, C);
+    if (A > B) std::swap(A, B);
+    return (unsigned long long) C * (C + 1) * (C + 2) / 6 + (unsigned long long) B * (B + 1) / 2 + A;
+}
+
+static unsigned long long gcd(unsigned long long a, unsigned long long b) {
+    while (b != 0) {
+        unsigned long long c = a % b;
+        a = b;
+        b = c;
+    }
+    return a;
+}
+
+static unsigned long long lcm(unsigned long long a, unsigned long long b) {
+    return a / gcd(a, b) * b;
+}
+
+/*
+ * The function that determines, for every conjugacy class T,
+ * the index of the class T* of the inverses of the elements of T.
+ */
+static std::vector<unsigned> determine_inverse_classes(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned> > & conj_classes,
+        const std::vector<unsigned> & class_of_elements) {
+    std::vector<unsigned> inverse_classes(conj_classes.size());
+    for (unsigned T = 0; T < conj_classes.size(); T++)
+        for (unsigned j = 0; j < multiplication.n_cols; j++)
+            if (multiplication(conj_classes[T][0], j) == 0) {
+                inverse_classes[T] = class_of_elements[j];
+                break;
+            }
+    return inverse_classes;
+}
+
+/*
+ * The functions that estimates (M_R)_{ST} matrices (see bulid_Ms)
+ * out of number_of_samples random products per one pair of conjugacy classes.
+ * The products are accumulated in sampled_products, so the consecutive calls
+ * (with the increasing number_of_samples) draw only the missing samples
+ * and enumerate each exact pair of classes only once.
+ *
+ * Outputs (besides the returned matrices):
+ * confidence:
+ * the smallest (over all the estimated Gamma numbers) distance of the estimate
+ * from the boundary of the rounding to the chosen value, measured in the standard errors of the estimate
+ * (negative if the chosen value is not the nearest one;
+ * the infinity if no constant has been estimated).
+ * is_exact:
+ * true if all the pairs of classes have been enumerated exactly.
+ */
+std::vector<arma::mat> estimate_Ms(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned> > & conj_classes,
+        SampledProducts & sampled_products, unsigned long long number_of_samples, std::mt19937 & generator, double & confidence, bool & is_exact) {
+    const unsigned number_of_conj_classes = conj_classes.size();
+    std::vector<unsigned> class_of_elements = determine_class_of_elements(conj_classes);
+    std::vector<unsigned> inverse_classes = determine_inverse_classes(multiplication, conj_classes, class_of_elements);
+    const unsigned number_of_pairs = number_of_conj_classes * (number_of_conj_classes + 1) / 2;
+    if (sampled_products.hits.size() != number_of_pairs) {
+        sampled_products.hits.assign(number_of_pairs, std::vector<unsigned long long>(number_of_conj_classes, 0));
+        sampled_products.number_of_draws.assign(number_of_pairs, 0);
+        sampled_products.is_exact.assign(number_of_pairs, false);
+    }
+    std::vector<GammaEstimate> gammas(gamma_index(0, 0, number_of_conj_classes));
+    is_exact = true;
+    // Zliczamy iloczyny r*s wpadajace do kolejnych klas T (dokladnie lub dolosowujac brakujace probki)
+    // i dodajemy uzyskane oszacowania do oszacowan odpowiednich Gamma(R, S, T*):
+    for (unsigned R = 0; R < number_of_conj_classes; R++)
+        for (unsigned S = R; S < number_of_conj_classes; S++) {
+            const unsigned pair = S * (S + 1) / 2 + R;
+            std::vector<unsigned long long> & hits = sampled_products.hits[pair];
+            unsigned long long & number_of_draws = sampled_products.number_of_draws[pair];
+            const unsigned long long number_of_products = (unsigned long long) conj_classes[R].size() * conj_classes[S].size();
+            if (!sampled_products.is_exact[pair] && number_of_products <= number_of_samples) {
+                std::fill(hits.begin(), hits.end(), 0);
+                for (unsigned r : conj_classes[R])
+                    for (unsigned s : conj_classes[S])
+                        hits[class_of_elements[multiplication(r, s)]]++;
+                number_of_draws = number_of_products;
+                sampled_products.is_exact[pair] = true;
+            } else if (!sampled_products.is_exact[pair]) {
+                std::uniform_int_distribution<unsigned> r_distribution(0, conj_classes[R].size() - 1);
+                std::uniform_int_distribution<unsigned> s_distribution(0, conj_classes[S].size() - 1);
+                for (; number_of_draws < number_of_samples; number_of_draws++) {
+                    unsigned r = conj_classes[R][r_distribution(generator)];
+                    unsigned s = conj_classes[S][s_distribution(generator)];
+                    hits[class_of_elements[multiplication(r, s)]]++;
+                }
+            }
+            const bool is_pair_exact = sampled_products.is_exact[pair];
+            if (!is_pair_exact) is_exact = false;
+            for (unsigned T = 0; T < number_of_conj_classes; T++) {
+                GammaEstimate & gamma = gammas[gamma_index(R, S, inverse_classes[T])];
+                if (is_pair_exact) {
+                    gamma.is_exact = true;
+                    gamma.value = hits[T];
+                } else {
+                    double p = (hits[T] + 0.5) / (number_of_draws + 1.0);
+                    double variance = number_of_products * p * (1 - p) / number_of_draws * number_of_products;
+                    gamma.weighted_sum += number_of_products * (double(hits[T]) / number_of_draws) / variance;
+                    gamma.weight += 1 / variance;
+                }
+            }
+        }
+    // Zaokraglamy oszacowania do wielokrotnosci lcm(|A|, |B|, |C|):
+    std::vector<unsigned long long> steps(gammas.size());
+    for (unsigned C = 0; C < number_of_conj_classes; C++)
+        for (unsigned B = 0; B <= C; B++)
+            for (unsigned A = 0; A <= B; A++) {
+                const unsigned long long index = gamma_index(A, B, C);
+                steps[index] = lcm(lcm(conj_classes[A].size(), conj_classes[B].size()), conj_classes[C].size());
+                GammaEstimate & gamma = gammas[index];
+                if (!gamma.is_exact)
+                    gamma.value = steps[index] * std::llround(gamma.weighted_sum / gamma.weight / steps[index]);
+            }
+    // Poprawiamy zaokraglenia, tam gdzie sa one najmniej pewne, az wiezy sum_T Gamma(R, S, T*) = |R| |S| beda spelnione
+    // (wartosci juz uzgodnione dla wczesniejszych par klas nie sa zmieniane):
+    for (unsigned R = 0; R < number_of_conj_classes; R++)
+        for (unsigned S = R; S < number_of_conj_classes; S++) {
+            long long residual = (long long) conj_classes[R].size() * conj_classes[S].size();
+            for (unsigned T = 0; T < number_of_conj_classes; T++)
+                residual -= (long long) gammas[gamma_index(R, S, inverse_classes[T])].value;
+            while (residual != 0) {
+                unsigned long long best_index = gammas.size();
+                double best_shift = -std::numeric_limits<double>::infinity();
+                for (unsigned T = 0; T < number_of_conj_classes; T++) {
+                    const unsigned long long index = gamma_index(R, S, inverse_classes[T]);
+                    const GammaEstimate & gamma = gammas[index];
+                    if (gamma.is_exact || gamma.is_locked || steps[index] > (unsigned long long) std::abs(residual)) continue;
+                    if (residual < 0 && gamma.value == 0) continue;
+                    double shift = (residual > 0 ? 1.0 : -1.0) * (gamma.weighted_sum / gamma.weight - gamma.value) / steps[index];
+                    if (shift > best_shift) {
+                        best_shift = shift;
+                        best_index = index;
+                    }
+                }
+                if (best_index == gammas.size()) break;
+                if (residual > 0) {
+                    gammas[best_index].value += steps[best_index];
+                    residual -= (long long) steps[best_index];
+                } else {
+                    gammas[best_index].value -= steps[best_index];
+                    residual += (long long) steps[best_index];
+                }
+            }
+            for (unsigned T = 0; T < number_of_conj_classes; T++)
+                gammas[gamma_index(R, S, inverse_classes[T])].is_locked = true;
+        }
+    // Oceniamy pewnosc zaokraglen (w jednostkach kroku zaokraglenia):
+    confidence = std::numeric_limits<double>::infinity();
+    for (unsigned long long index = 0; index < gammas.size(); index++) {
+        const GammaEstimate & gamma = gammas[index];
+        if (gamma.is_exact) continue;
+        double margin = 0.5 - std::abs(gamma.weighted_sum / gamma.weight - gamma.value) / steps[index];
+        double standard_error = 1 / sqrt(gamma.weight) / steps[index];
+        confidence = std::min(confidence, margin / standard_error);
+    }
+    // Budujemy macierze M: (M_R)_{ST} = |T| c_{RST} / sqrt(|S| |T|) = Gamma(R, S, T*) / sqrt(|S| |T|):
+    std::vector<arma::mat> Ms(number_of_conj_classes, arma::mat(number_of_conj_classes, number_of_conj_classes, arma::fill::zeros));
+    for (unsigned R = 0; R < number_of_conj_classes; R++)
+        for (unsigned S = 0; S < number_of_conj_classes; S++)
+            for (unsigned T = 0; T < number_of_conj_classes; T++)
+                Ms[R](S, T) = gammas[gamma_index(R, S, inverse_classes[T])].value / (sqrt(conj_classes[S].size()) * sqrt(conj_classes[T].size()));
+    return Ms;
+}
+
+/*
+ * The functions that verifies the character table
+ * via the orthogonality relations:
+ * sum_I |I| conj(chi_a(I)) chi_b(I) = |G| delta_{ab},
+ * sum_a conj(chi_a(I)) chi_a(J) = |G| / |I| delta_{IJ},
+ * and checks that the degrees chi_a(0) are positive integers.
+ * A table containing non-finite entries is rejected.
+ * The threshold is the allowed deviation of the degrees (absolute)
+ * and of the orthogonality relations (relative to the scale of the given relation:
+ * |G| for the rows, sqrt(|G| / |I|) sqrt(|G| / |J|) for the columns).
+ */
+bool verify_character_table(const std::vector<arma::cx_vec> & character_table, const std::vector<std::vector<unsigned> > & conj_classes, double threshold) {
+    const unsigned number_of_conj_classes = conj_classes.size();
+    double size_of_group = 0;
+    for (const std::vector<unsigned> & conj_class : conj_classes) size_of_group += conj_class.size();
+    if (character_table.size() != number_of_conj_classes) return false;
+    for (const arma::cx_vec & chis_row : character_table)
+        if (chis_row.n_rows != number_of_conj_classes) return false;
+    // Tabela zbudowana ze zle oszacowanych macierzy M moze zawierac NaN (np. gdy chi(0) = 0):
+    for (const arma::cx_vec & chis_row : character_table)
+        for (arma::cx_double chi : chis_row)
+            if (!std::isfinite(std::real(chi)) || !std::isfinite(std::imag(chi))) return false;
+    // (Warunki sa zapisane jako !(blad <= tolerancja), by NaN zawsze oznaczal niepowodzenie weryfikacji.)
+    for (const arma::cx_vec & chis_row : character_table) {
+        double degree = std::real(chis_row(0));
+        if (!(std::abs(chis_row(0) - std::round(degree)) <= threshold) || !(std::round(degree) >= 1)) return false;
+    }
+    for (unsigned a = 0; a < number_of_conj_classes; a++)
+        for (unsigned b = 0; b < number_of_conj_classes; b++) {
+            arma::cx_double product = 0;
+            for (unsigned I = 0; I < number_of_conj_classes; I++)
+                product += double(conj_classes[I].size()) * conj(character_table[a](I)) * character_table[b](I);
+            if (!(std::abs(product - (a == b ? size_of_group : 0.0)) <= threshold * size_of_group)) return false;
+        }
+    for (unsigned I = 0; I < number_of_conj_classes; I++)
+        for (unsigned J = 0; J < number_of_conj_classes; J++) {
+            arma::cx_double product = 0;
+            for (unsigned a = 0; a < number_of_conj_classes; a++)
+                product += conj(character_table[a](I)) * character_table[a](J);
+            const double scale = sqrt(size_of_group / conj_classes[I].size()) * sqrt(size_of_group / conj_classes[J].size());
+            if (!(std::abs(product - (I == J ? size_of_group / conj_classes[I].size() : 0.0)) <= threshold * scale)) return false;
+        }
+    return true;
+}
+
+/* 
+ * The functions that determines the character table
+ * out of the estimated (M_R)_{ST} matrices (see estimate_Ms).
+ * The number of samples starts at initial_number_of_samples
+ * and is doubled until the character table passes verify_character_table.
+ * Each pass is reported on the standard output.
+ * 
+ * Returns:
+ * The same as build_character_table.
+ */
+std::vector<arma::cx_vec> build_character_table_sampled(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned> > & conj_classes,
+        unsigned long long initial_number_of_samples, unsigned seed) {
+    std::mt19937 generator(seed);
+    SampledProducts sampled_products;
+    for (unsigned long long number_of_samples = std::max(initial_number_of_samples, 1ULL);; number_of_samples *= 2) {
+        double confidence;
+        bool is_exact;
+        std::vector<arma::mat> Ms = estimate_Ms(multiplication, conj_classes, sampled_products, number_of_samples, generator, confidence, is_exact);
+        std::vector<arma::cx_vec> character_table;
+        bool is_verified = false;
+        try {
+            character_table = build_character_table_from_Ms(Ms, conj_classes);
+            is_verified = verify_character_table(character_table, conj_classes);
+        } catch (const std::exception &) {
+            // Zle oszacowane macierze M moga nie dac sie (wspolnie) zdiagonalizowac.
+        }
+        std::cout << "Sampled class algebra: " << number_of_samples << " samples per pair of classes"
+                << (is_exact ? " (exact)" : "") << ", rounding confidence: " << confidence << " standard errors"
+                << ", verification: " << (is_verified ? "passed" : "failed") << "." << std::endl;
+        if (is_verified)
+            return character_table;
+        if (is_exact) {
+            std::string str = "The character table built out of the exact class algebra fails the verification.";
+            throw std::runtime_error(str);
+        }
+    }
+}
@@ -0,0 +1,269 @@
+#include<armadillo>
+#include<vector>
+#include<string>
+#include<cstdio>
+#include<stdexcept>
+#include<unistd.h>
+
+#include<burnside_algorithm.hpp>
+
+// *********************************************************************************************
+// ****************************  Sharded (M_R)_{ST} matrices building  *************************
+// *********************************************************************************************
+
+// The (M_R)_{ST} matrices are built shard by shard, one shard per one conjugacy class R.
+// The shard directory is first prepared by prepare_M_shards, that stores the conjugacy classes
+// (as the element -> class map) so that the shard jobs do not need to determine them again,
+// together with the hash of the group multiplication table.
+// A shard is stored as the fingerprint of the group and of its conjugacy classes
+// together with the matrix of counts returned by count_class_products
+// (saved in the armadillo binary format), in the file named by M_shard_file_name.
+// A shard that is already stored (and passes the consistency check) is not built again,
+// so the interrupted computations may be simply rerun.
+// All the files are first saved to temporary files and then renamed,
+// so an interrupted job never leaves a partial file behind.
+
+/*
+ * The function that saves the object to the file via a temporary file.
+ * The temporary file name is unique per process,
+ * so the jobs building the same file at the same time do not overwrite each other's temporary files.
+ */
+template<typename T>
+static void save_via_tmp_file(const T & object, const std::string & file_name) {
+    const std::string tmp_file_name = file_name + "." + std::to_string(getpid()) + ".tmp";
+    if (!object.save(tmp_file_name, arma::arma_binary) || std::rename(tmp_file_name.c_str(), file_name.c_str()) != 0) {
+        std::string str = "IO Error while the file " + file_name + " was writing.";
+        throw std::runtime_error(str);
+    }
+}
+
+/*
+ * The function that adds the value to the FNV-1a hash.
+ */
+static void fnv1a_update(arma::u64 & hash, arma::u64 value) {
+    hash ^= value;
+    hash *= 1099511628211ULL;
+}
+
+/*
+ * The functions that returns the FNV-1a hash of the group multiplication table.
+ */
+arma::u64 multiplication_hash(const arma::Mat<unsigned> & multiplication) {
+    arma::u64 hash = 14695981039346656037ULL;
+    fnv1a_update(hash, multiplication.n_rows);
+    fnv1a_update(hash, multiplication.n_cols);
+    for (unsigned j = 0; j < multiplication.n_cols; j++)
+        for (unsigned i = 0; i < multiplication.n_rows; i++)
+            fnv1a_update(hash, multiplication(i, j));
+    return hash;
+}
+
+/*
+ * The function that returns the fingerprint of the shards:
+ * the size of the group, the number of the classes,
+ * the FNV-1a hash of the element -> class map
+ * and the hash of the group multiplication table (see multiplication_hash).
+ */
+static arma::Mat<arma::u64> shard_fingerprint(const std::vector<std::vector<unsigned> > & conj_classes, arma::u64 multiplication_hash) {
+    std::vector<unsigned> class_of_elements = determine_class_of_elements(conj_classes);
+    arma::u64 hash = 14695981039346656037ULL;
+    for (unsigned T : class_of_elements)
+        fnv1a_update(hash, T);
+    arma::Mat<arma::u64> fingerprint(4, 1);
+    fingerprint(0, 0) = class_of_elements.size();
+    fingerprint(1, 0) = conj_classes.size();
+    fingerprint(2, 0) = hash;
+    fingerprint(3, 0) = multiplication_hash;
+    return fingerprint;
+}
+
+/*
+ * The functions that returns the path to the file holding the conjugacy classes
+ * (and the hash of the group multiplication table).
+ */
+std::string M_shards_conj_classes_file_name(const std::string & shard_dir) {
+    return shard_dir + "/conj_classes.partition";
+}
+
+/*
+ * The functions that returns the path to the file holding the shard for the class R.
+ */
+std::string M_shard_file_name(const std::string & shard_dir, unsigned R) {
+    return shard_dir + "/M_" + std::to_string(R) + ".shard";
+}
+
+/*
+ * The function that reads the file stored by prepare_M_shards:
+ * the element -> class map and the hash of the group multiplication table.
+ * Returns false if the file is missing or damaged.
+ */
+static bool load_prepared_M_shards(const std::string & shard_dir, arma::Mat<arma::u64> & class_of_elements, arma::u64 & multiplication_hash) {
+    arma::field<arma::Mat<arma::u64> > prepared;
+    if (!prepared.load(M_shards_conj_classes_file_name(shard_dir), arma::arma_binary) || prepared.n_elem != 2)
+        return false;
+    if (prepared(0).n_cols != 1 || prepared(1).n_rows != 1 || prepared(1).n_cols != 1)
+        return false;
+    class_of_elements = prepared(0);
+    multiplication_hash = prepared(1)(0, 0);
+    return true;
+}
+
+static void throw_not_prepared(const std::string & shard_dir) {
+    std::string str = "The shard directory " + shard_dir + " has not been prepared (the conjugacy classes file is missing or damaged).";
+    throw std::runtime_error(str);
+}
+
+/*
+ * The functions that reads the conjugacy classes stored by prepare_M_shards.
+ * The classes (and the elements within the classes) are ordered
+ * the same way as returned by determine_conj_classes.
+ * Throws std::runtime_error if the shard directory has not been prepared.
+ */
+std::vector<std::vector<unsigned> > load_M_shards_conj_classes(const std::string & shard_dir) {
+    arma::Mat<arma::u64> class_of_elements;
+    arma::u64 hash;
+    if (!load_prepared_M_shards(shard_dir, class_of_elements, hash))
+        throw_not_prepared(shard_dir);
+    std::vector<std::vector<unsigned> > conj_classes;
+    for (unsigned t = 0; t < class_of_elements.n_rows; t++) {
+        arma::u64 T = class_of_elements(t, 0);
+        if (T > conj_classes.size()) {
+            std::string str = "The conjugacy classes file in the shard directory " + shard_dir + " is damaged.";
+            throw std::runtime_error(str);
+        }
+        if (T == conj_classes.size()) conj_classes.push_back(std::vector<unsigned>());
+        conj_classes[T].push_back(t);
+    }
+    return conj_classes;
+}
+
+/*
+ * The functions that reads the hash of the group multiplication table stored by prepare_M_shards.
+ * Throws std::runtime_error if the shard directory has not been prepared.
+ */
+arma::u64 load_M_shards_multiplication_hash(const std::string & shard_dir) {
+    arma::Mat<arma::u64> class_of_elements;
+    arma::u64 hash;
+    if (!load_prepared_M_shards(shard_dir, class_of_elements, hash))
+        throw_not_prepared(shard_dir);
+    return hash;
+}
+
+/*
+ * The functions that prepares the shard_dir directory (the directory must exist)
+ * by storing there the conjugacy classes and the hash of the group multiplication table.
+ * Returns false if the directory has already been prepared for the same group (and does nothing then).
+ * Throws std::runtime_error if the directory has been prepared for other group or other conjugacy classes.
+ */
+bool prepare_M_shards(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned> > & conj_classes, const std::string & shard_dir) {
+    const arma::u64 hash = multiplication_hash(multiplication);
+    arma::Mat<arma::u64> stored_class_of_elements;
+    arma::u64 stored_hash;
+    if (load_prepared_M_shards(shard_dir, stored_class_of_elements, stored_hash)) {
+        if (stored_hash != hash || load_M_shards_conj_classes(shard_dir) != conj_classes) {
+            std::string str = "The shard directory " + shard_dir + " has been prepared for other group or other conjugacy classes.";
+            throw std::runtime_error(str);
+        }
+        return false;
+    }
+    std::vector<unsigned> class_of_elements = determine_class_of_elements(conj_classes);
+    arma::field<arma::Mat<arma::u64> > prepared(2);
+    prepared(0) = arma::Mat<arma::u64>(class_of_elements.size(), 1);
+    for (unsigned t = 0; t < class_of_elements.size(); t++)
+        prepared(0)(t, 0) = class_of_elements[t];
+    prepared(1) = arma::Mat<arma::u64>(1, 1);
+    prepared(1)(0, 0) = hash;
+    save_via_tmp_file(prepared, M_shards_conj_classes_file_name(shard_dir));
+    return true;
+}
+
+/*
+ * The function that reads the shard for the class R.
+ * Returns false if the shard file is missing, damaged or inconsistent with the conjugacy classes.
+ * The consistency checks: the stored fingerprint matches the conjugacy classes
+ * and the multiplication table hash stored by prepare_M_shards,
+ * and for each class S the counts sum up to |R| * |S|
+ * (since every product r*s falls into exactly one class).
+ */
+static bool load_M_shard(const std::vector<std::vector<unsigned> > & conj_classes, arma::u64 multiplication_hash, unsigned R,
+        const std::string & shard_dir, arma::Mat<arma::u64> & counts) {
+    const unsigned number_of_conj_classes = conj_classes.size();
+    arma::field<arma::Mat<arma::u64> > shard;
+    if (!shard.load(M_shard_file_name(shard_dir, R), arma::arma_binary) || shard.n_elem != 2)
+        return false;
+    const arma::Mat<arma::u64> fingerprint = shard_fingerprint(conj_classes, multiplication_hash);
+    if (shard(0).n_rows != fingerprint.n_rows || shard(0).n_cols != fingerprint.n_cols)
+        return false;
+    for (unsigned i = 0; i < fingerprint.n_rows; i++)
+        if (shard(0)(i, 0) != fingerprint(i, 0))
+            return false;
+    counts = shard(1);
+    if (counts.n_rows != number_of_conj_classes || counts.n_cols != number_of_conj_classes)
+        return false;
+    for (unsigned S = 0; S < number_of_conj_classes; S++)
+        if (arma::accu(counts.row(S)) != (arma::u64) conj_classes[R].size() * conj_classes[S].size())
+            return false;
+    return true;
+}
+
+/*
+ * The functions that checks whether the shard for the class R has already been built.
+ */
+bool is_M_shard_done(const std::vector<std::vector<unsigned> > & conj_classes, unsigned R, const std::string & shard_dir) {
+    arma::Mat<arma::u64> counts;
+    return load_M_shard(conj_classes, load_M_shards_multiplication_hash(shard_dir), R, shard_dir, counts);
+}
+
+/*
+ * The functions that builds the shard for the class R and stores it in the shard_dir directory.
+ * The conjugacy classes should be the ones stored by prepare_M_shards (see load_M_shards_conj_classes).
+ * Returns false if the shard has already been built (and does nothing then).
+ */
+bool build_M_shard(const arma::Mat<unsigned> & multiplication, const std::vector<std::vector<unsigned> > & conj_classes, unsigned R, const std::string & shard_dir) {
+    if (R >= conj_classes.size()) {
+        std::string str = "The shard index exceeds the number of conjugacy classes.";
+        throw std::out_of_range(str);
+    }
+    const arma::u64 hash = multiplication_hash(multiplication);
+    if (hash != load_M_shards_multiplication_hash(shard_dir)) {
+        std::string str = "The multiplication table does not match the one the shard directory " + shard_dir + " has been prepared for.";
+        throw std::invalid_argument(str);
+    }
+    arma::Mat<arma::u64> counts;
+    if (load_M_shard(conj_classes, hash, R, shard_dir, counts))
+        return false;
+    std::vector<unsigned> class_of_elements = determine_class_of_elements(conj_classes);
+    if (multiplication.n_rows != class_of_elements.size()) {
+        std::string str = "The conjugacy classes do not match the size of the group.";
+        throw std::invalid_argument(str);
+    }
+    arma::field<arma::Mat<arma::u64> > shard(2);
+    shard(0) = shard_fingerprint(conj_classes, hash);
+    shard(1) = count_class_products(multiplication, conj_classes, class_of_elements, R);
+    save_via_tmp_file(shard, M_shard_file_name(shard_dir, R));
+    return true;
+}
+
+/*
+ * The functions that combines all the shards stored in the shard_dir directory
+ * into the (M_R)_{ST} matrices (the same as returned by bulid_Ms).
+ * Throws std::runtime_error listing the missing shards if any shard has not been built yet
+ * (or has been built for other conjugacy classes).
+ */
+std::vector<arma::mat> merge_M_shards(const std::vector<std::vector<unsigned> > & conj_classes, const std::string & shard_dir) {
+    const arma::u64 hash = load_M_shards_multiplication_hash(shard_dir);
+    std::vector<arma::mat> Ms;
+    std::string missing_shards;
+    for (unsigned R = 0; R < conj_classes.size(); R++) {
+        arma::Mat<arma::u64> counts;
+        if (load_M_shard(conj_classes, hash, R, shard_dir, counts))
+            Ms.push_back(normalize_class_products(counts, conj_classes));
+        else
+            missing_shards += " " + std::to_string(R);
+    }
+    if (!missing_shards.empty()) {
+        std::string str = "The shards are missing or damaged for the classes:" + missing_shards + ".";
+        throw std::runtime_error(str);
+    }
+    return Ms;
+}
@@ -5,6 +5,7 @@
 #include<iostream>
 #include<iomanip>
 #include<memory>
+#include<string>
 
 #include<read_file_tools.hpp>
 #include<arma_patch.hpp>
@@ -60,28 +61,100 @@ void print_conj_classes(const std::vector<std::vector<unsigned> > & conjClasses)
     std::cout.flags(f);
 }
 
+void print_usage(const char* program_name) {
+    std::cerr << "The program determine the character table for given group." << std::endl;
+    std::cerr << "Input:  the group multiplication table." << std::endl;
+    std::cerr << "Output: the group character table." << std::endl;
+    std::cerr << "" << std::endl;
+    std::cerr << "Synopis:" << std::endl;
+    std::cerr << program_name << " path_to_matrix_file_with_multiplication_table" << std::endl;
+    std::cerr << program_name << " path_to_matrix_file_with_multiplication_table --prepare shard_dir" << std::endl;
+    std::cerr << program_name << " path_to_matrix_file_with_multiplication_table --shard class_index shard_dir" << std::endl;
+    std::cerr << program_name << " --merge shard_dir" << std::endl;
+    std::cerr << program_name << " path_to_matrix_file_with_multiplication_table --sampled [initial_number_of_samples [shard_dir]]" << std::endl;
+    std::cerr << "" << std::endl;
+    std::cerr << "The --prepare mode determines the conjugacy classes and stores them in the (existing) shard_dir directory." << std::endl;
+    std::cerr << "The --shard mode builds the part of the computations related to one conjugacy class" << std::endl;
+    std::cerr << "and stores it in the prepared shard_dir directory. The already built shards are skipped." << std::endl;
+    std::cerr << "The --merge mode combines all the shards from shard_dir and outputs the group character table" << std::endl;
+    std::cerr << "(the multiplication table is not needed in this mode)." << std::endl;
+    std::cerr << "The --sampled mode estimates the class algebra from random products (for very large groups)," << std::endl;
+    std::cerr << "the number of samples is doubled until the character table passes the orthogonality verification." << std::endl;
+    std::cerr << "If shard_dir is given, the conjugacy classes stored there by --prepare are used;" << std::endl;
+    std::cerr << "otherwise they are determined, which costs more than the exact computations (about k*|G|^2 operations)." << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
-        std::cerr << "The program determine the character table for given group." << std::endl;
-        std::cerr << "Input:  the group multiplication table." << std::endl;
-        std::cerr << "Output: the group character table." << std::endl;
-        std::cerr << "" << std::endl;
-        std::cerr << "Synopis:" << std::endl;
-        std::cerr << argv[0] << " path_to_matrix_file_with_multiplication_table" << std::endl;                
+    const bool prepare_mode = (argc == 4 && std::string(argv[2]) == "--prepare");
+    const bool shard_mode = (argc == 5 && std::string(argv[2]) == "--shard");
+    const bool merge_mode = (argc == 3 && std::string(argv[1]) == "--merge");
+    const bool sampled_mode = ((argc == 3 || argc == 4 || argc == 5) && std::string(argv[2]) == "--sampled");
+    if (argc != 2 && !prepare_mode && !shard_mode && !merge_mode && !sampled_mode) {
+        print_usage(argv[0]);
         return 1;
     }
+    if (merge_mode) {
+        // Laczymy czesci macierzy M (klasy sprzezonosci sa zapisane w katalogu, tabela mnozenia nie jest potrzebna):
+        const std::string shard_dir = argv[2];
+        std::vector<std::vector<unsigned> > conj_classes = load_M_shards_conj_classes(shard_dir);
+        std::cout << std::endl;
+        print_conj_classes(conj_classes);
+        std::cout << std::endl;
+        std::vector<arma::cx_vec> character_table = build_character_table_from_Ms(merge_M_shards(conj_classes, shard_dir), conj_classes);
+        print_character_table(character_table);
+        return 0;
+    }
     // Czytanie pliku zawierajacego tabele mnozenia grupowego:
     std::string fileName = argv[1];
     std::shared_ptr<arma::Mat<unsigned>> multiplication_ptr(file_to_mat<unsigned>(fileName));
     std::cout << std::endl;
-    multiplication_ptr->print("Group multiplication table:");
-    std::cout << std::endl;
-    // Znajdujemy klasy sprzezonosci:
-    std::vector<std::vector<unsigned> > conj_classes = determine_conj_classes(*multiplication_ptr);
+    if (prepare_mode) {
+        // Znajdujemy klasy sprzezonosci (raz dla wszystkich czesci) i zapisujemy je w katalogu:
+        const std::string shard_dir = argv[3];
+        std::vector<std::vector<unsigned> > conj_classes = determine_conj_classes(*multiplication_ptr);
+        std::cout << "Number of conjugacy classes: " << conj_classes.size() << std::endl;
+        if (prepare_M_shards(*multiplication_ptr, conj_classes, shard_dir))
+            std::cout << "The shard directory has been prepared: " << shard_dir << std::endl;
+        else
+            std::cout << "The shard directory has already been prepared (skipped): " << shard_dir << std::endl;
+        return 0;
+    }
+    if (shard_mode) {
+        // Liczymy jedna czesc macierzy M (o ile nie zostala policzona wczesniej):
+        const unsigned R = std::stoul(argv[3]);
+        const std::string shard_dir = argv[4];
+        std::vector<std::vector<unsigned> > conj_classes = load_M_shards_conj_classes(shard_dir);
+        if (build_M_shard(*multiplication_ptr, conj_classes, R, shard_dir))
+            std::cout << "The shard has been built: " << M_shard_file_name(shard_dir, R) << std::endl;
+        else
+            std::cout << "The shard has already been built (skipped): " << M_shard_file_name(shard_dir, R) << std::endl;
+        return 0;
+    }
+    if (!sampled_mode) {
+        multiplication_ptr->print("Group multiplication table:");
+        std::cout << std::endl;
+    }
+    // Znajdujemy klasy sprzezonosci (lub wczytujemy je z przygotowanego katalogu):
+    std::vector<std::vector<unsigned> > conj_classes;
+    if (sampled_mode && argc == 5) {
+        const std::string shard_dir = argv[4];
+        if (multiplication_hash(*multiplication_ptr) != load_M_shards_multiplication_hash(shard_dir)) {
+            std::cerr << "The multiplication table does not match the one the shard directory " << shard_dir << " has been prepared for." << std::endl;
+            return 1;
+        }
+        conj_classes = load_M_shards_conj_classes(shard_dir);
+    } else
+        conj_classes = determine_conj_classes(*multiplication_ptr);
     print_conj_classes(conj_classes);
     std::cout << std::endl;
     // Znajdujemy tabele charakterow:
-    std::vector<arma::cx_vec> character_table = build_character_table(*multiplication_ptr);
+    std::vector<arma::cx_vec> character_table;
+    if (sampled_mode && argc >= 4)
+        character_table = build_character_table_sampled(*multiplication_ptr, conj_classes, std::stoull(argv[3]));
+    else if (sampled_mode)
+        character_table = build_character_table_sampled(*multiplication_ptr, conj_classes);
+    else
+        character_table = build_character_table(*multiplication_ptr, conj_classes);
     // Wypisywanie wynikow:
     print_character_table(character_table);
 }